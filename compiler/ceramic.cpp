@@ -18,6 +18,7 @@
 #include "invoketables.hpp"
 #include "loader.hpp"
 #include "parachute.hpp"
+#include "perfmap.hpp"
 
 using std::string;
 using std::vector;
@@ -48,7 +49,7 @@ static bool runModule(llvm::Module *module,
                       char const *const *envp,
                       llvm::ArrayRef<std::string> libSearchPaths,
                       llvm::ArrayRef<std::string> libs, unsigned optLevel,
-                      HiResTimer *jitCompileTimer = nullptr,
+                      bool perfMap, HiResTimer *jitCompileTimer = nullptr,
                       HiResTimer *execTimer = nullptr) {
     auto JTMB_expected = llvm::orc::JITTargetMachineBuilder::detectHost();
     if (!JTMB_expected) {
@@ -90,6 +91,9 @@ static bool runModule(llvm::Module *module,
     auto JIT = std::move(JIT_expected.get());
     llvm::orc::LLJIT &jit = *JIT;
 
+    if (perfMap)
+        enablePerfMap(jit);
+
     llvm::orc::JITDylib &mainDylib = jit.getMainJITDylib();
 
     auto Generator_expected =
@@ -184,7 +188,7 @@ static bool runModule(llvm::Module *module,
 }
 
 static void optimizeLLVM(llvm::Module *module, unsigned optLevel,
-                         bool internalize) {
+                         bool internalize, bool thinLTO) {
     llvm::LoopAnalysisManager LAM;
     llvm::FunctionAnalysisManager FAM;
     llvm::CGSCCAnalysisManager CGAM;
@@ -205,7 +209,11 @@ static void optimizeLLVM(llvm::Module *module, unsigned optLevel,
     else if (optLevel >= 3)
         O = llvm::OptimizationLevel::O3;
 
-    llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(O);
+    // with -flto=thin, leave inlining across units and the rest of the
+    // whole-program work to the link
+    llvm::ModulePassManager MPM =
+        thinLTO ? PB.buildThinLTOPreLinkDefaultPipeline(O)
+                : PB.buildPerModuleDefaultPipeline(O);
 
     if (optLevel > 2 && internalize) {
         MPM.addPass(llvm::InternalizePass([=](const llvm::GlobalValue &GV) {
@@ -218,7 +226,34 @@ static void optimizeLLVM(llvm::Module *module, unsigned optLevel,
     MPM.run(*module, MAM);
 }
 
-static void generateLLVM(llvm::Module *module, bool emitAsm,
+// Fold functions with identical bodies into one. Generic code instantiated
+// for types of the same layout, such as Vector[Int64] and Vector[UInt64] or
+// vectors of any pointer type, compiles to the same IR under different code
+// names. Returns how many functions were folded into another one.
+static unsigned mergeFunctions(llvm::Module *module) {
+    // a merged function is either erased or has its body replaced by a
+    // thunk, and in both cases its first original instruction is deleted
+    vector<llvm::WeakVH> bodies;
+    for (llvm::Function &f : *module)
+        if (!f.isDeclaration())
+            bodies.emplace_back(&f.getEntryBlock().front());
+
+    llvm::ModuleAnalysisManager MAM;
+    llvm::PassBuilder PB;
+    PB.registerModuleAnalyses(MAM);
+
+    llvm::ModulePassManager MPM;
+    MPM.addPass(llvm::MergeFunctionsPass());
+    MPM.run(*module, MAM);
+
+    unsigned merged = 0;
+    for (const llvm::WeakVH &body : bodies)
+        if (body == nullptr)
+            ++merged;
+    return merged;
+}
+
+static void generateLLVM(llvm::Module *module, bool emitAsm, bool thinLTO,
                          llvm::raw_ostream *out) {
     llvm::LoopAnalysisManager LAM;
     llvm::FunctionAnalysisManager FAM;
@@ -237,7 +272,9 @@ static void generateLLVM(llvm::Module *module, bool emitAsm,
     if (emitAsm)
         passes.addPass(llvm::PrintModulePass(*out));
     else
-        passes.addPass(llvm::BitcodeWriterPass(*out));
+        passes.addPass(llvm::BitcodeWriterPass(
+            *out, /*ShouldPreserveUseListOrder=*/false,
+            /*EmitSummaryIndex=*/thinLTO, /*EmitModuleHash=*/thinLTO));
 
     passes.run(*module, MAM);
 }
@@ -279,6 +316,8 @@ static bool generateBinary(llvm::Module *module,
                            llvm::Twine const &outputFilePath,
                            llvm::StringRef const &clangPath,
                            bool /*exceptions*/, bool sharedLib, bool debug,
+                           bool thinLTO, unsigned optLevel,
+                           llvm::StringRef linker,
                            llvm::ArrayRef<string> arguments, bool verbose) {
     int fd;
     PathString tempObj;
@@ -293,7 +332,10 @@ static bool generateBinary(llvm::Module *module,
     {
         llvm::raw_fd_ostream objOut(fd, /*shouldClose=*/true);
 
-        generateAssembly(module, targetMachine, &objOut, true);
+        if (thinLTO)
+            generateLLVM(module, false, true, &objOut);
+        else
+            generateAssembly(module, targetMachine, &objOut, true);
     }
 
     string outputFilePathStr = outputFilePath.str();
@@ -335,6 +377,23 @@ static bool generateBinary(llvm::Module *module,
             clangArgs.emplace_back(linkerFlags);
         }
     }
+    // without -fuse-ld, ThinLTO links with lld where it is installed; any
+    // other linker needs clang's LTO plugin for it
+    string useLinker;
+    if (!linker.empty())
+        useLinker = "-fuse-ld=" + linker.str();
+    else if (thinLTO && !triple.isOSDarwin() &&
+             llvm::sys::findProgramByName("ld.lld"))
+        useLinker = "-fuse-ld=lld";
+    if (!useLinker.empty())
+        clangArgs.emplace_back(useLinker);
+    string ltoOptLevel = "-O" + std::to_string(optLevel);
+    if (thinLTO) {
+        // the object is bitcode with a summary; the linker plugin does the
+        // ThinLTO backend for it and any other -flto=thin unit on the line
+        clangArgs.emplace_back("-flto=thin");
+        clangArgs.emplace_back(ltoOptLevel);
+    }
     if (debug) {
         if (triple.getOS() == llvm::Triple::Win32)
             clangArgs.emplace_back("-Wl,/debug");
@@ -416,7 +475,17 @@ static void usage(const char *argv0) {
     llvm::errs() << "  -O0 -O1 -O2 -O3       set optimization level\n";
     llvm::errs()
         << "                        (default -O0, pass -O2 for release)\n";
-    llvm::errs() << "  -g                    keep debug symbol information\n";
+    llvm::errs()
+        << "  -merge-functions      fold identical instantiations into one\n"
+        << "                        (default with -O2 and -O3)\n";
+    llvm::errs()
+        << "  -no-merge-functions   keep every instantiation separate\n";
+    llvm::errs() << "  -merge-report         show how many functions were "
+                    "merged\n";
+    llvm::errs() << "  -g                    keep debug symbol information\n"
+                 << "                        (combines with any -O level)\n";
+    llvm::errs() << "  -gline-tables-only    keep only line tables for "
+                    "backtraces and profiling\n";
     llvm::errs() << "  -exceptions           enable exception handling\n";
     llvm::errs() << "  -no-exceptions        disable exception handling\n";
     llvm::errs()
@@ -441,6 +510,18 @@ static void usage(const char *argv0) {
                     "writing to disk\n"
                  << "                        use -- to pass arguments to the "
                     "program: -run file.crm -- arg1 arg2\n";
+    llvm::errs() << "  -perf-map             write /tmp/perf-<pid>.map for JIT "
+                    "code (-run, -repl)\n";
+    llvm::errs()
+        << "  -flto=thin            emit bitcode with a ThinLTO summary and\n"
+        << "                        link with ThinLTO (with lld if found); -c\n"
+        << "                        units share identical instantiations at link\n";
+    llvm::errs()
+        << "  -fuse-ld=<linker>     link with <linker> (passed to clang)\n";
+    llvm::errs()
+        << "  -finstrument          record entry/exit of every procedure\n"
+        << "                        (trace written at exit, see module "
+           "instrument)\n";
     llvm::errs() << "  -timing               show timing information\n";
     llvm::errs() << "  -verbose              be verbose\n";
     llvm::errs() << "  -full-match-errors    show universal patterns in match "
@@ -535,6 +616,12 @@ int main2(int argc, char **argv, char const *const *envp) {
     bool exceptions = true;
     bool run = false;
     bool repl = false;
+    bool perfMap = false;
+    bool instrument = false;
+    bool thinLTO = false;
+    bool mergeFunctionsSet = false;
+    bool mergeFunctionsEnabled = false;
+    bool mergeReport = false;
     bool verbose = false;
     bool crossCompiling = false;
     bool showTiming = false;
@@ -544,7 +631,6 @@ int main2(int argc, char **argv, char const *const *envp) {
     bool generateDeps = false;
 
     unsigned optLevel = 0;
-    bool optLevelSet = false;
 
     bool finalOverloadsEnabled = false;
     bool softFloat = false;
@@ -568,6 +654,7 @@ int main2(int argc, char **argv, char const *const *envp) {
     vector<string> libSearchPathArgs;
     vector<string> libSearchPath;
     string linkerFlags;
+    string linker;
     vector<string> librariesArgs;
     vector<string> libraries;
     vector<PathString> searchPath;
@@ -579,6 +666,7 @@ int main2(int argc, char **argv, char const *const *envp) {
 #endif
 
     bool debug = false;
+    bool debugLineTablesOnly = false;
 
     for (int i = 1; i < argc; ++i) {
         if ((strcmp(argv[i], "-shared") == 0)) {
@@ -591,20 +679,26 @@ int main2(int argc, char **argv, char const *const *envp) {
             emitObject = true;
         } else if (strcmp(argv[i], "-g") == 0) {
             debug = true;
-            if (!optLevelSet)
-                optLevel = 0;
+            debugLineTablesOnly = false;
+        } else if (strcmp(argv[i], "-gline-tables-only") == 0) {
+            debug = true;
+            debugLineTablesOnly = true;
         } else if (strcmp(argv[i], "-O0") == 0) {
             optLevel = 0;
-            optLevelSet = true;
         } else if (strcmp(argv[i], "-O1") == 0) {
             optLevel = 1;
-            optLevelSet = true;
         } else if (strcmp(argv[i], "-O2") == 0) {
             optLevel = 2;
-            optLevelSet = true;
         } else if (strcmp(argv[i], "-O3") == 0) {
             optLevel = 3;
-            optLevelSet = true;
+        } else if (strcmp(argv[i], "-merge-functions") == 0) {
+            mergeFunctionsEnabled = true;
+            mergeFunctionsSet = true;
+        } else if (strcmp(argv[i], "-no-merge-functions") == 0) {
+            mergeFunctionsEnabled = false;
+            mergeFunctionsSet = true;
+        } else if (strcmp(argv[i], "-merge-report") == 0) {
+            mergeReport = true;
         } else if (strcmp(argv[i], "-inline") == 0) {
             inlineEnabled = true;
         } else if (strcmp(argv[i], "-no-inline") == 0) {
@@ -622,6 +716,12 @@ int main2(int argc, char **argv, char const *const *envp) {
             run = true;
         } else if (strcmp(argv[i], "-repl") == 0) {
             repl = true;
+        } else if (strcmp(argv[i], "-perf-map") == 0) {
+            perfMap = true;
+        } else if (strcmp(argv[i], "-flto=thin") == 0) {
+            thinLTO = true;
+        } else if (strcmp(argv[i], "-finstrument") == 0) {
+            instrument = true;
         } else if (strcmp(argv[i], "-timing") == 0) {
             showTiming = true;
         } else if (strcmp(argv[i], "-full-match-errors") == 0) {
@@ -742,6 +842,12 @@ int main2(int argc, char **argv, char const *const *envp) {
             }
         } else if (strcmp(argv[i], "-soft-float") == 0) {
             softFloat = true;
+        } else if (strstr(argv[i], "-fuse-ld=") == argv[i]) {
+            linker = argv[i] + strlen("-fuse-ld=");
+            if (linker.empty()) {
+                llvm::errs() << "error: linker missing after -fuse-ld=\n";
+                return 1;
+            }
         } else if (strstr(argv[i], "-Wl") == argv[i]) {
             linkerFlags += argv[i] + strlen("-Wl");
         } else if (strstr(argv[i], "-L") == argv[i]) {
@@ -919,11 +1025,21 @@ int main2(int argc, char **argv, char const *const *envp) {
     if (!codegenExternalsSet)
         codegenExternals = !(emitLLVM || emitAsm || emitObject);
 
+    if (!mergeFunctionsSet)
+        mergeFunctionsEnabled = optLevel >= 2;
+
     if ((emitLLVM || emitAsm || emitObject) && run)
         run = false;
 
+    if (thinLTO && (run || repl)) {
+        llvm::errs() << "warning: -flto=thin is ignored with -run and -repl\n";
+        thinLTO = false;
+    }
+
     setInlineEnabled(inlineEnabled);
     setExceptionsEnabled(exceptions);
+    setInstrumentEnabled(instrument);
+    setThinLTOEnabled(thinLTO);
 
     setFinalOverloadsEnabled(finalOverloadsEnabled);
 
@@ -939,7 +1055,8 @@ int main2(int argc, char **argv, char const *const *envp) {
     initTimer.start();
     llvm::TargetMachine *targetMachine =
         initLLVM(targetTriple, targetCPU, targetFeatures, softFloat, moduleName,
-                 "", (sharedLib || genPIC), debug, optLevel);
+                 "", (sharedLib || genPIC), debug, debugLineTablesOnly,
+                 optLevel);
     if (targetMachine == nullptr) {
         llvm::errs() << "error: unable to initialize LLVM for target "
                      << targetTriple << "\n";
@@ -1093,27 +1210,42 @@ int main2(int argc, char **argv, char const *const *envp) {
         }
 
         bool internalize = true;
-        if (debug || sharedLib || run || !codegenExternals)
+        if (sharedLib || run || !codegenExternals || thinLTO)
             internalize = false;
 
         optTimer.start();
 
+        // merge once before optimizing, to optimize less code, and once
+        // after, when inlining has made more instantiations identical
+        unsigned functionCount = 0;
+        unsigned mergedCount = 0;
         if (!repl) {
+            for (llvm::Function &f : *llvmModule)
+                if (!f.isDeclaration())
+                    ++functionCount;
+            if (mergeFunctionsEnabled)
+                mergedCount += mergeFunctions(llvmModule);
             if (optLevel > 0)
-                optimizeLLVM(llvmModule, optLevel, internalize);
+                optimizeLLVM(llvmModule, optLevel, internalize, thinLTO);
+            if (mergeFunctionsEnabled && optLevel > 0)
+                mergedCount += mergeFunctions(llvmModule);
         }
         optTimer.stop();
 
+        if (mergeReport)
+            llvm::errs() << "merged functions = " << mergedCount << " of "
+                         << functionCount << "\n";
+
         if (run) {
             vector<string> runArgs;
             runArgs.push_back(ceramicFile.empty() ? "-e" : ceramicFile);
             runArgs.insert(runArgs.end(), programArgs.begin(),
                            programArgs.end());
             runModule(llvmModule, runArgs, envp, libSearchPath, libraries,
-                      optLevel, &outputTimer, &execTimer);
+                      optLevel, perfMap, &outputTimer, &execTimer);
         } else if (repl) {
             // TODO: future me task
-            runInteractive(llvmModule, m);
+            runInteractive(llvmModule, m, perfMap);
         } else if (emitLLVM || emitAsm || emitObject) {
             std::error_code ec;
 
@@ -1124,8 +1256,8 @@ int main2(int argc, char **argv, char const *const *envp) {
                 return 1;
             }
             outputTimer.start();
-            if (emitLLVM)
-                generateLLVM(llvmModule, emitAsm, &out);
+            if (emitLLVM || (emitObject && thinLTO))
+                generateLLVM(llvmModule, emitAsm, thinLTO, &out);
             else if (emitAsm || emitObject)
                 generateAssembly(llvmModule, targetMachine, &out, emitObject);
             outputTimer.stop();
@@ -1157,7 +1289,8 @@ int main2(int argc, char **argv, char const *const *envp) {
             outputTimer.start();
             result = generateBinary(llvmModule, targetMachine, outputFile,
                                     clangPath, exceptions, sharedLib, debug,
-                                    arguments, verbose);
+                                    thinLTO, optLevel, linker, arguments,
+                                    verbose);
             outputTimer.stop();
             if (!result)
                 return 1;
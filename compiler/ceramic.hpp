@@ -43,6 +43,7 @@
 #include <llvm/IR/PassManager.h>
 #include <llvm/IR/TrackingMDRef.h>
 #include <llvm/IR/Type.h>
+#include <llvm/IR/ValueHandle.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/IRPrinter/IRPrintingPasses.h>
 #include <llvm/MC/TargetRegistry.h>
@@ -65,6 +66,7 @@
 #include <llvm/TargetParser/Host.h>
 #include <llvm/TargetParser/Triple.h>
 #include <llvm/Transforms/IPO/Internalize.h>
+#include <llvm/Transforms/IPO/MergeFunctions.h>
 #include <llvm/Transforms/InstCombine/InstCombine.h>
 #include <llvm/Transforms/Scalar/GVN.h>
 
@@ -2146,7 +2148,7 @@ struct Env : public Object {
 // interactive module
 //
 
-void runInteractive(llvm::Module *llvmModule, ModulePtr module);
+void runInteractive(llvm::Module *llvmModule, ModulePtr module, bool perfMap);
 
 //
 // Types
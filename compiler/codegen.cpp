@@ -20,7 +20,10 @@
 
 #include "codegen.hpp"
 
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/InstIterator.h>
 
 #pragma clang diagnostic ignored "-Wcovered-switch-default"
 
@@ -31,7 +34,14 @@ llvm::DICompileUnit *llvmDICompileUnit = nullptr;
 const llvm::DataLayout *llvmDataLayout;
 llvm::LLVMContext llvmContext;
 
-static vector<CValuePtr> initializedGlobals;
+// globals shared across units are destroyed by a call under their guard
+struct InitializedGlobal {
+    CValuePtr value;
+    llvm::GlobalVariable *guard;
+    llvm::Function *destroy;
+};
+
+static vector<InitializedGlobal> initializedGlobals;
 static CodegenContext *constructorsCtx = nullptr;
 static CodegenContext *destructorsCtx = nullptr;
 
@@ -46,6 +56,10 @@ llvm::Value *noExceptionReturnValue() {
     return llvm::ConstantPointerNull::get(exceptionReturnType());
 }
 
+static CodegenContext *setUpSimpleContext(CodegenContext *ctx,
+                                          const char *name);
+static void finalizeSimpleContext(CodegenContext *ctx, ObjectPtr errorProc);
+
 void codegenValueInit(CValuePtr dest, CodegenContext *ctx);
 
 void codegenValueDestroy(CValuePtr dest, CodegenContext *ctx);
@@ -195,11 +209,13 @@ void codegenMultiExprAssign(ExprListPtr left, MultiCValuePtr mcvRight,
                             CodegenContext *ctx);
 
 //
-// flags for inline/exceptions
+// flags for inline/exceptions/instrument/thinlto
 //
 
 static bool _inlineEnabled = true;
 static bool _exceptionsEnabled = true;
+static bool _instrumentEnabled = false;
+static bool _thinLTOEnabled = false;
 
 bool inlineEnabled() { return _inlineEnabled; }
 
@@ -209,6 +225,20 @@ bool exceptionsEnabled() { return _exceptionsEnabled; }
 
 void setExceptionsEnabled(bool enabled) { _exceptionsEnabled = enabled; }
 
+bool instrumentEnabled() { return _instrumentEnabled; }
+
+void setInstrumentEnabled(bool enabled) { _instrumentEnabled = enabled; }
+
+bool thinLTOEnabled() { return _thinLTOEnabled; }
+
+void setThinLTOEnabled(bool enabled) { _thinLTOEnabled = enabled; }
+
+static bool _debugLineTablesOnly = false;
+
+bool fullDebugInfoEnabled() {
+    return llvmDIBuilder != nullptr && !_debugLineTablesOnly;
+}
+
 //
 // utility procs
 //
@@ -1217,6 +1247,294 @@ void codegenStaticObject(ObjectPtr x, CodegenContext *ctx, MultiCValuePtr out) {
     }
 }
 
+//
+// instances shared across units
+//
+
+// Under -flto=thin an instance gets linkonce_odr linkage, so the copies
+// instantiated by separately compiled units are merged at link time, when
+// its code name denotes the same code in every unit. That is not so for
+// anything declared in the main module, for lambdas, whose names are only
+// unique within one program, or for open variants, which each program
+// gives its own set of instances. A name is only a candidate, though: the
+// body behind it can still differ when it calls or reads something that is
+// not shared, a main module overload of a library procedure, say, so
+// linkSharedInstances keeps an instance internal unless everything it
+// reaches is shared as well.
+static bool sharedAcrossUnits(ObjectPtr x);
+
+static bool sharedAcrossUnits(llvm::ArrayRef<TypePtr> types) {
+    for (const TypePtr &t : types)
+        if (!sharedAcrossUnits(t.ptr()))
+            return false;
+    return true;
+}
+
+static bool sharedAcrossUnits(llvm::ArrayRef<ObjectPtr> params) {
+    for (const ObjectPtr &param : params)
+        if (!sharedAcrossUnits(param))
+            return false;
+    return true;
+}
+
+static bool sharedAcrossUnitsModule(ObjectPtr x) {
+    ModulePtr m = staticModule(x);
+    return m != nullptr && m->moduleName != "__main__";
+}
+
+static bool sharedAcrossUnits(ObjectPtr x) {
+    switch (x->objKind) {
+    case TYPE: {
+        Type *t = (Type *)x.ptr();
+        switch (t->typeKind) {
+        case BOOL_TYPE:
+        case INTEGER_TYPE:
+        case FLOAT_TYPE:
+        case COMPLEX_TYPE:
+            return true;
+        case POINTER_TYPE:
+            return sharedAcrossUnits(((PointerType *)t)->pointeeType.ptr());
+        case CODE_POINTER_TYPE: {
+            CodePointerType *y = (CodePointerType *)t;
+            return sharedAcrossUnits(y->argTypes) &&
+                   sharedAcrossUnits(y->returnTypes);
+        }
+        case CCODE_POINTER_TYPE: {
+            CCodePointerType *y = (CCodePointerType *)t;
+            return sharedAcrossUnits(y->argTypes) &&
+                   (y->returnType == nullptr ||
+                    sharedAcrossUnits(y->returnType.ptr()));
+        }
+        case ARRAY_TYPE:
+            return sharedAcrossUnits(((ArrayType *)t)->elementType.ptr());
+        case VEC_TYPE:
+            return sharedAcrossUnits(((VecType *)t)->elementType.ptr());
+        case TUPLE_TYPE:
+            return sharedAcrossUnits(((TupleType *)t)->elementTypes);
+        case UNION_TYPE:
+            return sharedAcrossUnits(((UnionType *)t)->memberTypes);
+        case RECORD_TYPE: {
+            RecordType *y = (RecordType *)t;
+            return sharedAcrossUnits(y->record.ptr()) &&
+                   sharedAcrossUnits(y->params);
+        }
+        case VARIANT_TYPE: {
+            VariantType *y = (VariantType *)t;
+            return sharedAcrossUnits(y->variant.ptr()) &&
+                   sharedAcrossUnits(y->params);
+        }
+        case STATIC_TYPE:
+            return sharedAcrossUnits(((StaticType *)t)->obj);
+        case ENUM_TYPE:
+        case NEW_TYPE:
+            return sharedAcrossUnitsModule(x);
+        default:
+            return false;
+        }
+    }
+    case PROCEDURE:
+        return ((Procedure *)x.ptr())->lambda == nullptr &&
+               sharedAcrossUnitsModule(x);
+    case RECORD_DECL:
+        return ((RecordDecl *)x.ptr())->lambda == nullptr &&
+               sharedAcrossUnitsModule(x);
+    case VARIANT_DECL:
+        return !((VariantDecl *)x.ptr())->open && sharedAcrossUnitsModule(x);
+    case GLOBAL_VARIABLE:
+    case GLOBAL_ALIAS:
+    case EXTERNAL_PROCEDURE:
+    case EXTERNAL_VARIABLE:
+    case MODULE:
+        return sharedAcrossUnitsModule(x);
+    case PRIM_OP:
+    case INTRINSIC:
+    case IDENTIFIER:
+    case VALUE_HOLDER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool sharedAcrossUnits(InvokeEntry *entry) {
+    ModulePtr m = safeLookupModule(entry->env);
+    return thinLTOEnabled() && m != nullptr && m->moduleName != "__main__" &&
+           sharedAcrossUnits(entry->callable) &&
+           sharedAcrossUnits(entry->argsKey) &&
+           sharedAcrossUnits(entry->returnTypes);
+}
+
+static bool sharedAcrossUnits(GVarInstance *x, TypePtr type) {
+    ModulePtr m = safeLookupModule(x->env);
+    return thinLTOEnabled() && m != nullptr && m->moduleName != "__main__" &&
+           sharedAcrossUnits(x->gvar.ptr()) && sharedAcrossUnits(x->params) &&
+           sharedAcrossUnits(type.ptr());
+}
+
+// A shared global is initialized by whichever unit's constructor runs
+// first and destroyed by whichever destructor runs first, as told by its
+// guard, which is merged along with it.
+struct SharedGlobal {
+    llvm::GlobalVariable *global;
+    llvm::GlobalVariable *guard;
+    llvm::Function *init;
+    llvm::Function *destroy;
+};
+
+static llvm::SetVector<llvm::Function *> sharedFunctionCandidates;
+static vector<SharedGlobal> sharedGlobalCandidates;
+
+// a function whose name was taken already: two instances print the same
+// code name, so it can't be trusted as an identity for either of them
+static void addSharedCandidate(llvm::Function *llFunc,
+                               llvm::StringRef codeName, bool candidate) {
+    if (llFunc->getName() != codeName) {
+        if (llvm::Function *clash = llvmModule->getFunction(codeName))
+            sharedFunctionCandidates.remove(clash);
+    } else if (candidate) {
+        sharedFunctionCandidates.insert(llFunc);
+    }
+}
+
+using SharedSet = llvm::SmallPtrSet<llvm::GlobalValue *, 32>;
+
+static bool reachesOnlyShared(llvm::Value *v, const SharedSet &shared,
+                              llvm::SmallPtrSetImpl<llvm::Value *> &visited);
+
+// globals with external linkage are one symbol in every unit, and local
+// constants, string literals among them, are the same wherever they are
+// copied as long as what they point to is
+static bool sharedGlobalValue(llvm::GlobalValue *gv, const SharedSet &shared,
+                              llvm::SmallPtrSetImpl<llvm::Value *> &visited) {
+    if (!gv->hasLocalLinkage() || shared.count(gv))
+        return true;
+    llvm::GlobalVariable *var = llvm::dyn_cast<llvm::GlobalVariable>(gv);
+    return var != nullptr && var->isConstant() && var->hasInitializer() &&
+           reachesOnlyShared(var->getInitializer(), shared, visited);
+}
+
+static bool reachesOnlyShared(llvm::Value *v, const SharedSet &shared,
+                              llvm::SmallPtrSetImpl<llvm::Value *> &visited) {
+    if (!visited.insert(v).second)
+        return true;
+    if (llvm::GlobalValue *gv = llvm::dyn_cast<llvm::GlobalValue>(v))
+        return sharedGlobalValue(gv, shared, visited);
+    if (llvm::Constant *c = llvm::dyn_cast<llvm::Constant>(v)) {
+        for (llvm::Value *op : c->operands())
+            if (!reachesOnlyShared(op, shared, visited))
+                return false;
+    }
+    return true;
+}
+
+static bool reachesOnlyShared(llvm::Function *f, const SharedSet &shared) {
+    llvm::SmallPtrSet<llvm::Value *, 32> visited;
+    if (f->hasPersonalityFn() &&
+        !reachesOnlyShared(f->getPersonalityFn(), shared, visited))
+        return false;
+    for (llvm::Instruction &inst : llvm::instructions(*f))
+        for (llvm::Value *op : inst.operands())
+            if (llvm::isa<llvm::Constant>(op) &&
+                !reachesOnlyShared(op, shared, visited))
+                return false;
+    return true;
+}
+
+// drop candidates until every shared function reaches only shared
+// functions and globals, and every shared global is initialized and
+// destroyed by shared functions; then link what is left linkonce_odr
+static void linkSharedInstances() {
+    SharedSet shared;
+    vector<llvm::Function *> functions(sharedFunctionCandidates.begin(),
+                                       sharedFunctionCandidates.end());
+    for (llvm::Function *f : functions)
+        shared.insert(f);
+    for (const SharedGlobal &g : sharedGlobalCandidates) {
+        shared.insert(g.global);
+        shared.insert(g.guard);
+        shared.insert(g.init);
+        shared.insert(g.destroy);
+        functions.push_back(g.init);
+        functions.push_back(g.destroy);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (llvm::Function *f : functions) {
+            if (shared.count(f) && !reachesOnlyShared(f, shared)) {
+                shared.erase(f);
+                changed = true;
+            }
+        }
+        for (const SharedGlobal &g : sharedGlobalCandidates) {
+            if (shared.count(g.global) &&
+                !(shared.count(g.init) && shared.count(g.destroy))) {
+                shared.erase(g.global);
+                shared.erase(g.guard);
+                changed = true;
+            }
+        }
+    }
+
+    for (llvm::GlobalValue *gv : shared) {
+        gv->setLinkage(llvm::GlobalValue::LinkOnceODRLinkage);
+        gv->setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+    sharedFunctionCandidates.clear();
+    sharedGlobalCandidates.clear();
+}
+
+// call f from ctx if guard is clear, setting it, or if it is set, clearing it
+static void codegenGuardedCall(llvm::GlobalVariable *guard, bool whenSet,
+                               llvm::Function *f, CodegenContext *ctx) {
+    llvm::Type *flagType = guard->getValueType();
+    llvm::Value *flag = ctx->builder->CreateLoad(flagType, guard);
+    llvm::Value *set = ctx->builder->CreateICmpNE(
+        flag, llvm::ConstantInt::get(flagType, 0));
+    llvm::BasicBlock *callBlock = newBasicBlock("guardedCall", ctx);
+    llvm::BasicBlock *doneBlock = newBasicBlock("guardedDone", ctx);
+    if (whenSet)
+        ctx->builder->CreateCondBr(set, callBlock, doneBlock);
+    else
+        ctx->builder->CreateCondBr(set, doneBlock, callBlock);
+    ctx->builder->SetInsertPoint(callBlock);
+    ctx->builder->CreateStore(llvm::ConstantInt::get(flagType, whenSet ? 0 : 1),
+                              guard);
+    ctx->builder->CreateCall(f);
+    ctx->builder->CreateBr(doneBlock);
+    ctx->builder->SetInsertPoint(doneBlock);
+}
+
+// a global that may be merged with the same global of other units gets
+// functions of its own to initialize and destroy it, so that
+// linkSharedInstances can tell whether they are the same in every unit
+static void codegenSharedGlobal(GVarInstancePtr x, StatementPtr init,
+                                TypePtr type, llvm::StringRef symbol) {
+    llvm::GlobalVariable *guard = new llvm::GlobalVariable(
+        *llvmModule, llvmIntType(8), false,
+        llvm::GlobalVariable::InternalLinkage,
+        llvm::ConstantInt::get(llvmIntType(8), 0), symbol + " guard");
+
+    CodegenContext initCtx;
+    setUpSimpleContext(&initCtx, (symbol + " init").str().c_str());
+    bool result = codegenStatement(init, x->env, &initCtx);
+    assert(!result);
+    finalizeSimpleContext(&initCtx, operator_exceptionInInitializer());
+
+    CodegenContext destroyCtx;
+    setUpSimpleContext(&destroyCtx, (symbol + " destroy").str().c_str());
+    codegenValueDestroy(new CValue(type, x->llGlobal), &destroyCtx);
+    finalizeSimpleContext(&destroyCtx, operator_exceptionInFinalizer());
+
+    codegenGuardedCall(guard, false, initCtx.llvmFunc, constructorsCtx);
+
+    sharedGlobalCandidates.push_back(
+        {x->llGlobal, guard, initCtx.llvmFunc, destroyCtx.llvmFunc});
+    initializedGlobals.push_back(
+        {new CValue(type, x->llGlobal), guard, destroyCtx.llvmFunc});
+}
+
 //
 // codegenGVarInstance
 //
@@ -1252,7 +1570,7 @@ void codegenGVarInstance(GVarInstancePtr x) {
     x->llGlobal = new llvm::GlobalVariable(
         *llvmModule, llvmType(y.type), false,
         llvm::GlobalVariable::InternalLinkage, initializer, symbolStr.str());
-    if (llvmDIBuilder != nullptr) {
+    if (fullDebugInfoEnabled()) {
         unsigned line, column;
         llvm::DIFile *file = getDebugLineCol(x->gvar->location, line, column);
         llvm::DIGlobalVariableExpression *gve =
@@ -1282,13 +1600,18 @@ void codegenGVarInstance(GVarInstancePtr x) {
     lhs->location = x->gvar->name->location;
     StatementPtr init = new InitAssignment(lhs, x->expr);
     init->location = x->gvar->location;
+    if (sharedAcrossUnits(x.ptr(), y.type)) {
+        codegenSharedGlobal(x, init, y.type, symbolStr.str());
+        return;
+    }
     bool result = codegenStatement(init, x->env, constructorsCtx);
     assert(!result);
 
     // generate destructor procedure body
     codegenCallable(operator_destroy(), PVData(y.type, false));
 
-    initializedGlobals.push_back(new CValue(y.type, x->llGlobal));
+    initializedGlobals.push_back({new CValue(y.type, x->llGlobal), nullptr,
+                                  nullptr});
 }
 
 //
@@ -1309,7 +1632,7 @@ void codegenExternalVariable(ExternalVariablePtr x) {
     else if (x->attrDLLExport)
         x->llGlobal->setDLLStorageClass(
             llvm::GlobalValue::DLLExportStorageClass);
-    if (llvmDIBuilder != nullptr) {
+    if (fullDebugInfoEnabled()) {
         unsigned line, column;
         llvm::DIFile *file = getDebugLineCol(x->location, line, column);
         llvm::DIGlobalVariableExpression *gve =
@@ -1395,12 +1718,16 @@ void codegenExternalProcedure(ExternalProcedurePtr x, bool codegenBody) {
             file = getDebugLineCol(x->location, line, column);
 
             vector<llvm::Metadata *> debugParamTypes;
-            if (x->returnType2 == nullptr)
-                debugParamTypes.push_back(llvmVoidTypeDebugInfo());
-            else
-                debugParamTypes.push_back(llvmTypeDebugInfo(x->returnType2));
-            for (size_t i = 0; i < x->args.size(); ++i)
-                debugParamTypes.push_back(llvmTypeDebugInfo(x->args[i]->type2));
+            if (fullDebugInfoEnabled()) {
+                if (x->returnType2 == nullptr)
+                    debugParamTypes.push_back(llvmVoidTypeDebugInfo());
+                else
+                    debugParamTypes.push_back(
+                        llvmTypeDebugInfo(x->returnType2));
+                for (size_t i = 0; i < x->args.size(); ++i)
+                    debugParamTypes.push_back(
+                        llvmTypeDebugInfo(x->args[i]->type2));
+            }
 
             llvm::DITypeRefArray debugParamArray =
                 llvmDIBuilder->getOrCreateTypeArray(debugParamTypes);
@@ -1471,7 +1798,7 @@ void codegenExternalProcedure(ExternalProcedurePtr x, bool codegenBody) {
         CValuePtr cvalue = extFunc->allocArgumentValue(
             extFunc->argInfos[i], arg->name->str, ai, &ctx);
         addLocal(env, arg->name, cvalue.ptr());
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             unsigned line, column;
             Location argLocation = arg->location;
             llvm::DIFile *file = getDebugLineCol(argLocation, line, column);
@@ -2556,6 +2883,13 @@ void codegenLLVMBody(InvokeEntry *entry, llvm::StringRef callableName) {
 
     entry->llvmFunc = llvmModule->getFunction(functionName.str());
     assert(entry->llvmFunc);
+
+    // the numbered name only keeps bodies apart within one unit
+    if (thinLTOEnabled()) {
+        entry->llvmFunc->setName(callableName);
+        addSharedCandidate(entry->llvmFunc, callableName,
+                           sharedAcrossUnits(entry));
+    }
 }
 
 //
@@ -2628,6 +2962,70 @@ string getCodeName(InvokeEntry *entry) {
 // codegenCodeBody
 //
 
+// procedures of the runtime module are never instrumented, the hooks
+// would otherwise record the writing of the trace itself
+static bool shouldInstrument(InvokeEntry *entry) {
+    if (!instrumentEnabled())
+        return false;
+    ModulePtr m = safeLookupModule(entry->env);
+    return m == nullptr || m->moduleName != "instrument";
+}
+
+static void codegenInstrumentHook(llvm::StringRef hookName,
+                                  llvm::Value *callableName,
+                                  llvm::IRBuilder<> &builder) {
+    llvm::FunctionCallee hook = llvmModule->getOrInsertFunction(
+        hookName, llvmVoidType(),
+        llvm::PointerType::getUnqual(llvmContext));
+    builder.CreateCall(hook, {callableName});
+}
+
+static llvm::DISubprogram *codegenDebugSubprogram(InvokeEntry *entry,
+                                                  llvm::StringRef name,
+                                                  llvm::StringRef linkageName) {
+    unsigned line, column;
+    llvm::DIFile *file =
+        getDebugLineCol(entry->origCode->location, line, column);
+
+    vector<llvm::Metadata *> debugParamTypes;
+    if (fullDebugInfoEnabled()) {
+        debugParamTypes.push_back(llvmVoidTypeDebugInfo());
+        for (size_t i = 0; i < entry->argsKey.size(); ++i) {
+            llvm::DIType *argType = llvmTypeDebugInfo(entry->argsKey[i]);
+            llvm::DIType *argRefType = llvmDIBuilder->createReferenceType(
+                llvm::dwarf::DW_TAG_reference_type, argType);
+            debugParamTypes.push_back(argRefType);
+        }
+        for (size_t i = 0; i < entry->returnTypes.size(); ++i) {
+            llvm::DIType *returnType = llvmTypeDebugInfo(entry->returnTypes[i]);
+            llvm::DIType *returnRefType =
+                entry->returnIsRef[i]
+                    ? llvmDIBuilder->createReferenceType(
+                          llvm::dwarf::DW_TAG_reference_type,
+                          llvmDIBuilder->createReferenceType(
+                              llvm::dwarf::DW_TAG_reference_type, returnType))
+                    : llvmDIBuilder->createReferenceType(
+                          llvm::dwarf::DW_TAG_reference_type, returnType);
+
+            debugParamTypes.push_back(returnRefType);
+        }
+    }
+
+    llvm::DITypeRefArray debugParamArray =
+        llvmDIBuilder->getOrCreateTypeArray(debugParamTypes);
+
+    llvm::DISubroutineType *typeDebugInfo =
+        llvmDIBuilder->createSubroutineType(debugParamArray);
+
+    return llvmDIBuilder->createFunction(
+        lookupModuleDebugInfo(entry->env), name, linkageName, file, line,
+        typeDebugInfo,
+        line,                   // scope line
+        llvm::DINode::FlagZero, // flags
+        llvm::DISubprogram::SPFlagLocalToUnit |
+            llvm::DISubprogram::SPFlagDefinition);
+}
+
 static bool blockIsNop(llvm::BasicBlock *codeBlock,
                        llvm::BasicBlock *returnBlock) {
     if (codeBlock->size() == 1) {
@@ -2669,6 +3067,8 @@ void codegenCodeBody(InvokeEntry *entry) {
 
     llvm::Function *llFunc = llvm::Function::Create(
         llFuncType, llvm::Function::InternalLinkage, llvmFuncName, llvmModule);
+    if (thinLTOEnabled())
+        addSharedCandidate(llFunc, llvmFuncName, sharedAcrossUnits(entry));
 
     switch (entry->isInline) {
     case INLINE:
@@ -2695,42 +3095,8 @@ void codegenCodeBody(InvokeEntry *entry) {
     llvm::DIFile *file = nullptr;
     if (llvmDIBuilder != nullptr) {
         file = getDebugLineCol(entry->origCode->location, line, column);
-
-        vector<llvm::Metadata *> debugParamTypes;
-        debugParamTypes.push_back(llvmVoidTypeDebugInfo());
-        for (size_t i = 0; i < entry->argsKey.size(); ++i) {
-            llvm::DIType *argType = llvmTypeDebugInfo(entry->argsKey[i]);
-            llvm::DIType *argRefType = llvmDIBuilder->createReferenceType(
-                llvm::dwarf::DW_TAG_reference_type, argType);
-            debugParamTypes.push_back(argRefType);
-        }
-        for (size_t i = 0; i < entry->returnTypes.size(); ++i) {
-            llvm::DIType *returnType = llvmTypeDebugInfo(entry->returnTypes[i]);
-            llvm::DIType *returnRefType =
-                entry->returnIsRef[i]
-                    ? llvmDIBuilder->createReferenceType(
-                          llvm::dwarf::DW_TAG_reference_type,
-                          llvmDIBuilder->createReferenceType(
-                              llvm::dwarf::DW_TAG_reference_type, returnType))
-                    : llvmDIBuilder->createReferenceType(
-                          llvm::dwarf::DW_TAG_reference_type, returnType);
-
-            debugParamTypes.push_back(returnRefType);
-        }
-
-        llvm::DITypeRefArray debugParamArray =
-            llvmDIBuilder->getOrCreateTypeArray(debugParamTypes);
-
-        llvm::DISubroutineType *typeDebugInfo =
-            llvmDIBuilder->createSubroutineType(debugParamArray);
-
-        llvm::DISubprogram *sp = llvmDIBuilder->createFunction(
-            lookupModuleDebugInfo(entry->env), callableName, llvmFuncName, file,
-            line, typeDebugInfo,
-            line,                   // scope line
-            llvm::DINode::FlagZero, // flags
-            llvm::DISubprogram::SPFlagLocalToUnit |
-                llvm::DISubprogram::SPFlagDefinition);
+        llvm::DISubprogram *sp =
+            codegenDebugSubprogram(entry, callableName, llvmFuncName);
         entry->llvmFunc->setSubprogram(sp);
         entry->debugInfo.reset(sp);
 
@@ -2767,7 +3133,7 @@ void codegenCodeBody(InvokeEntry *entry) {
         CValuePtr cvalue = new CValue(entry->fixedArgTypes[i], llArgValue,
                                       entry->forwardedRValueFlags[i]);
         addLocal(env, entry->fixedArgNames[i], cvalue.ptr());
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             unsigned line, column;
             Location argLocation = entry->origCode->formalArgs[i]->location;
             llvm::DIFile *file = getDebugLineCol(argLocation, line, column);
@@ -2812,7 +3178,7 @@ void codegenCodeBody(InvokeEntry *entry) {
                                           entry->forwardedRValueFlags[i + j]);
             varArgs->add(cvalue);
 
-            if (llvmDIBuilder != nullptr) {
+            if (fullDebugInfoEnabled()) {
                 llvm::DILocation *debugLoc = llvm::DILocation::get(
                     llvmContext, line, column, entry->getDebugInfo());
                 llvm::DILocalVariable *debugVar =
@@ -2842,7 +3208,7 @@ void codegenCodeBody(InvokeEntry *entry) {
             CValuePtr cvalue = new CValue(entry->fixedArgTypes[i], llArgValue,
                                           entry->forwardedRValueFlags[i + j]);
             addLocal(env, entry->fixedArgNames[i], cvalue.ptr());
-            if (llvmDIBuilder != nullptr) {
+            if (fullDebugInfoEnabled()) {
                 unsigned line, column;
                 Location argLocation = entry->origCode->formalArgs[i]->location;
                 llvm::DIFile *file = getDebugLineCol(argLocation, line, column);
@@ -2900,7 +3266,7 @@ void codegenCodeBody(InvokeEntry *entry) {
                 sout << "return.." << i;
             returns[i].value->llValue->setName(sout.str());
 
-            if (rspec->name != nullptr && llvmDIBuilder != nullptr) {
+            if (rspec->name != nullptr && fullDebugInfoEnabled()) {
                 unsigned line, column;
                 Location argLocation = rspec->location;
                 llvm::DIFile *file = getDebugLineCol(argLocation, line, column);
@@ -2954,17 +3320,31 @@ void codegenCodeBody(InvokeEntry *entry) {
 
     entry->runtimeNop = blockIsNop(codeBlock, returnBlock);
 
+    llvm::Value *instrumentName = nullptr;
+    if (shouldInstrument(entry)) {
+        instrumentName = ctx.initBuilder->CreateGlobalString(
+            callableName, "instrument.name");
+        codegenInstrumentHook("ceramic_instrument_enter", instrumentName,
+                              *ctx.initBuilder);
+    }
+
     ctx.initBuilder->CreateBr(codeBlock);
 
     returnBlock->moveAfter(ctx.builder->GetInsertBlock());
     exceptionBlock->moveAfter(returnBlock);
 
     ctx.builder->SetInsertPoint(returnBlock);
+    if (instrumentName != nullptr)
+        codegenInstrumentHook("ceramic_instrument_exit", instrumentName,
+                              *ctx.builder);
     llvm::Value *llRet = noExceptionReturnValue();
     ctx.builder->CreateRet(llRet);
 
     ctx.builder->SetInsertPoint(exceptionBlock);
     assert(ctx.exceptionValue != nullptr);
+    if (instrumentName != nullptr)
+        codegenInstrumentHook("ceramic_instrument_exit", instrumentName,
+                              *ctx.builder);
     llvm::Value *llExcept =
         ctx.builder->CreateLoad(exceptionReturnType(), ctx.exceptionValue);
     ctx.builder->CreateRet(llExcept);
@@ -2974,6 +3354,37 @@ void codegenCodeBody(InvokeEntry *entry) {
 // codegenCallInline
 //
 
+// Give the body of a forceinline procedure the procedure's own debug scope,
+// inlined at the caller's current location, as LLVM's inliner would. Returns
+// false, leaving the body at the caller's location, when there is no call site
+// location to refer to.
+static bool pushInlinedDebugScope(InvokeEntry *entry, CodegenContext *ctx) {
+    if (llvmDIBuilder == nullptr || !ctx->tracksDebugLocations())
+        return false;
+    llvm::DILocation *callSite = ctx->builder->getCurrentDebugLocation().get();
+    if (callSite == nullptr)
+        return false;
+
+    if (entry->getDebugInfo() == nullptr)
+        entry->debugInfo.reset(
+            codegenDebugSubprogram(entry, getCodeName(entry), ""));
+
+    unsigned line, column;
+    llvm::DIFile *file =
+        getDebugLineCol(entry->origCode->location, line, column);
+    ctx->pushDebugScope(llvmDIBuilder->createLexicalBlock(
+        entry->getDebugInfo(), file, line, column));
+    ctx->inlinedAt.push_back(llvm::TrackingMDNodeRef(callSite));
+    return true;
+}
+
+static void popInlinedDebugScope(CodegenContext *ctx) {
+    llvm::DILocation *callSite = ctx->getInlinedAt();
+    ctx->inlinedAt.pop_back();
+    ctx->popDebugScope();
+    ctx->builder->SetCurrentDebugLocation(callSite);
+}
+
 void codegenCallInline(InvokeEntry *entry, MultiCValuePtr args,
                        CodegenContext *ctx, MultiCValuePtr out) {
     assert(entry->isInline == FORCE_INLINE);
@@ -2981,6 +3392,7 @@ void codegenCallInline(InvokeEntry *entry, MultiCValuePtr args,
     if (entry->code->isLLVMBody())
         error(entry->code, "llvm procedures cannot be inlined");
 
+    bool inlinedDebugScope = pushInlinedDebugScope(entry, ctx);
     ++ctx->inlineDepth;
 
     ensureArity(args, entry->argsKey.size());
@@ -3074,6 +3486,8 @@ void codegenCallInline(InvokeEntry *entry, MultiCValuePtr args,
 
     --ctx->inlineDepth;
     assert(ctx->inlineDepth >= 0);
+    if (inlinedDebugScope)
+        popInlinedDebugScope(ctx);
 }
 
 //
@@ -3884,7 +4298,7 @@ EnvPtr codegenBinding(BindingPtr x, EnvPtr env, CodegenContext *ctx) {
         for (unsigned i = 0; i < mpv->values.size(); ++i) {
             CValuePtr cv = codegenAllocNewValue(mpv->values[i].type, ctx);
             mcv->add(cv);
-            if (llvmDIBuilder != nullptr) {
+            if (fullDebugInfoEnabled()) {
                 llvm::DILexicalBlock *debugBlock = ctx->getDebugScope();
                 llvm::DILocalVariable *debugVar =
                     llvmDIBuilder->createAutoVariable(
@@ -3950,7 +4364,7 @@ EnvPtr codegenBinding(BindingPtr x, EnvPtr env, CodegenContext *ctx) {
             TypePtr ptrType = pointerType(pv.type);
             CValuePtr cvRef = codegenAllocNewValue(ptrType, ctx);
             mcv->add(cvRef);
-            if (llvmDIBuilder != nullptr) {
+            if (fullDebugInfoEnabled()) {
                 llvm::DILexicalBlock *debugBlock = ctx->getDebugScope();
                 llvm::DILocalVariable *debugVar =
                     llvmDIBuilder->createAutoVariable(
@@ -4019,7 +4433,7 @@ EnvPtr codegenBinding(BindingPtr x, EnvPtr env, CodegenContext *ctx) {
                 cv = codegenAllocNewValue(ptrType, ctx);
             }
             mcv->add(cv);
-            if (llvmDIBuilder != nullptr) {
+            if (fullDebugInfoEnabled()) {
                 llvm::DILexicalBlock *debugBlock = ctx->getDebugScope();
                 llvm::DIType *debugType = llvmTypeDebugInfo(pv.type);
                 llvm::DILocalVariable *debugVar =
@@ -4342,8 +4756,12 @@ static void finalizeCtorsDtors() {
     finalizeSimpleContext(constructorsCtx, operator_exceptionInInitializer());
 
     for (size_t i = initializedGlobals.size(); i > 0; --i) {
-        CValuePtr cv = initializedGlobals[i - 1];
-        codegenValueDestroy(cv, destructorsCtx);
+        InitializedGlobal const &g = initializedGlobals[i - 1];
+        if (g.guard != nullptr) {
+            codegenGuardedCall(g.guard, true, g.destroy, destructorsCtx);
+            continue;
+        }
+        codegenValueDestroy(g.value, destructorsCtx);
     }
     finalizeSimpleContext(destructorsCtx, operator_exceptionInFinalizer());
 }
@@ -4489,6 +4907,8 @@ void codegenEntryPoints(ModulePtr module, bool importedExternals) {
 
     timers.finalize.start();
     finalizeCtorsDtors();
+    if (thinLTOEnabled())
+        linkSharedInstances();
 
     if (llvmDIBuilder != nullptr) {
         materializeDebugInfoForTypes();
@@ -4508,7 +4928,8 @@ llvm::TargetMachine *initLLVM(llvm::StringRef targetTriple,
                               llvm::StringRef targetCPU,
                               llvm::StringRef targetFeatures, bool softFloat,
                               llvm::StringRef name, llvm::StringRef flags,
-                              bool relocPic, bool debug, unsigned optLevel) {
+                              bool relocPic, bool debug,
+                              bool debugLineTablesOnly, unsigned optLevel) {
     llvm::InitializeAllTargets();
     llvm::InitializeAllTargetMCs();
     llvm::InitializeAllAsmPrinters();
@@ -4516,6 +4937,7 @@ llvm::TargetMachine *initLLVM(llvm::StringRef targetTriple,
 
     llvmModule = new llvm::Module(name, llvmContext);
     llvmModule->setTargetTriple(targetTriple);
+    _debugLineTablesOnly = debug && debugLineTablesOnly;
     if (debug) {
         llvm::SmallString<260> absFileName(name);
         llvm::sys::fs::make_absolute(absFileName);
@@ -4526,7 +4948,9 @@ llvm::TargetMachine *initLLVM(llvm::StringRef targetTriple,
                 llvm::sys::path::filename(absFileName),
                 llvm::sys::path::parent_path(absFileName)),
             "ceramic compiler " CERAMIC_COMPILER_VERSION, optLevel > 0, flags,
-            0);
+            0, "",
+            debugLineTablesOnly ? llvm::DICompileUnit::LineTablesOnly
+                                : llvm::DICompileUnit::FullDebug);
         llvmModule->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
                                   llvm::DEBUG_METADATA_VERSION);
         llvmModule->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
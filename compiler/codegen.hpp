@@ -20,12 +20,20 @@ llvm::TargetMachine *initLLVM(llvm::StringRef targetTriple,
                               llvm::StringRef targetCPU,
                               llvm::StringRef targetFeatures, bool softFloat,
                               llvm::StringRef name, llvm::StringRef flags,
-                              bool relocPic, bool debug, unsigned optLevel);
+                              bool relocPic, bool debug,
+                              bool debugLineTablesOnly, unsigned optLevel);
 
 bool inlineEnabled();
 void setInlineEnabled(bool enabled);
 bool exceptionsEnabled();
 void setExceptionsEnabled(bool enabled);
+bool instrumentEnabled();
+void setInstrumentEnabled(bool enabled);
+bool thinLTOEnabled();
+void setThinLTOEnabled(bool enabled);
+
+// true when debug info describes types and variables, not only line tables
+bool fullDebugInfoEnabled();
 
 void initExternalTarget(string target);
 
@@ -119,6 +127,8 @@ struct ValueStackEntry {
 struct CodegenContext {
     llvm::Function *llvmFunc;
     vector<llvm::TrackingMDNodeRef> debugScope;
+    // call sites of the forceinline procedures being generated, innermost last
+    vector<llvm::TrackingMDNodeRef> inlinedAt;
     std::unique_ptr<llvm::IRBuilder<>> initBuilder;
     std::unique_ptr<llvm::IRBuilder<>> builder;
 
@@ -160,6 +170,19 @@ struct CodegenContext {
     }
 
     void popDebugScope() { debugScope.pop_back(); }
+
+    llvm::DILocation *getInlinedAt() {
+        if (inlinedAt.empty())
+            return nullptr;
+        else
+            return llvm::cast<llvm::DILocation>(inlinedAt.back().get());
+    }
+
+    // locations are only tracked while every inline level is a forceinline
+    // call with its own debug scope, not an alias (call-by-name) expansion
+    bool tracksDebugLocations() const {
+        return inlineDepth == static_cast<int>(inlinedAt.size());
+    }
 };
 
 struct DebugLocationContext {
@@ -170,11 +193,13 @@ struct DebugLocationContext {
         : loc(loc), ctx(ctx) {
         if (loc.ok()) {
             pushLocation(loc);
-            if (llvmDIBuilder != nullptr && ctx->inlineDepth == 0) {
+            if (llvmDIBuilder != nullptr && ctx->tracksDebugLocations()) {
                 unsigned line, column;
                 getDebugLineCol(loc, line, column);
-                llvm::DebugLoc debugLoc = llvm::DILocation::get(
-                    llvmContext, line, column, ctx->getDebugScope());
+                llvm::DebugLoc debugLoc =
+                    llvm::DILocation::get(llvmContext, line, column,
+                                          ctx->getDebugScope(),
+                                          ctx->getInlinedAt());
                 ctx->builder->SetCurrentDebugLocation(debugLoc);
             }
         }
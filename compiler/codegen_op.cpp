@@ -2090,8 +2090,11 @@ void codegenPrimOp(PrimOpPtr x, MultiCValuePtr args, CodegenContext *ctx,
         if (ptrT->pointeeType != newvT)
             argumentTypeError(3, ptrT->pointeeType, newvT);
 
+        // a failed exchange only loads, so it cannot have release ordering
+        llvm::AtomicOrdering failureOrder =
+            llvm::AtomicCmpXchgInst::getStrongestFailureOrdering(order);
         llvm::Value *cmpxchg = ctx->builder->CreateAtomicCmpXchg(
-            ptr, oldv, newv, llvm::MaybeAlign(), order, order);
+            ptr, oldv, newv, llvm::MaybeAlign(), order, failureOrder);
         llvm::Value *result = ctx->builder->CreateExtractValue(cmpxchg, 0);
 
         assert(out->size() == 1);
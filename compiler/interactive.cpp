@@ -6,6 +6,7 @@
 #include "lexer.hpp"
 #include "loader.hpp"
 #include "parser.hpp"
+#include "perfmap.hpp"
 
 #include <csetjmp>
 #include <csignal>
@@ -291,7 +292,8 @@ static void exceptionHandler(int i) {
     longjmp(recovery, 1);
 }
 
-void runInteractive(llvm::Module *llvmModule_, ModulePtr module_) {
+void runInteractive(llvm::Module *llvmModule_, ModulePtr module_,
+                    bool perfMap) {
     signal(SIGABRT, exceptionHandler);
 
     llvmModule = llvmModule_;
@@ -311,6 +313,9 @@ void runInteractive(llvm::Module *llvmModule_, ModulePtr module_) {
     }
     jit = std::move(*expectedJIT);
 
+    if (perfMap)
+        enablePerfMap(*jit);
+
     llvm::orc::JITDylib &mainDylib = jit->getMainJITDylib();
 
     auto generatorExpected =
@@ -456,11 +456,22 @@ static ModulePtr loadPrelude(vector<string> *sourceFiles, bool verbose,
     }
 }
 
+// code compiled with -finstrument calls hooks defined by the runtime module
+// `instrument`, so link it into every program without importing any names
+static void addRuntimeImports(ModulePtr m) {
+    if (instrumentEnabled()) {
+        DottedNamePtr dottedName = new DottedName();
+        dottedName->parts.push_back(Identifier::get("instrument"));
+        m->imports.push_back(new ImportMembers(dottedName));
+    }
+}
+
 ModulePtr loadProgram(llvm::StringRef fileName, vector<string> *sourceFiles,
                       bool verbose, bool repl) {
     timers.parse.start();
     globalMainModule = parse("", loadFile(fileName, sourceFiles));
     timers.parse.stop();
+    addRuntimeImports(globalMainModule);
     ModulePtr prelude = loadPrelude(sourceFiles, verbose, repl);
     loadDependents(globalMainModule, sourceFiles, verbose);
     timers.install.start();
@@ -484,6 +495,7 @@ ModulePtr loadProgramSource(llvm::StringRef name, llvm::StringRef source,
     timers.parse.start();
     globalMainModule = parse("", mainSource);
     timers.parse.stop();
+    addRuntimeImports(globalMainModule);
     // Don't keep track of source files for -e script
     ModulePtr prelude = loadPrelude(nullptr, verbose, repl);
     loadDependents(globalMainModule, nullptr, verbose);
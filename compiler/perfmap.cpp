@@ -0,0 +1,90 @@
+#include "perfmap.hpp"
+
+#include <memory>
+#include <mutex>
+#include <system_error>
+
+#include <llvm/ExecutionEngine/JITLink/JITLink.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Process.h>
+
+namespace ceramic {
+
+namespace {
+
+class PerfMapPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
+    std::mutex mutex;
+    std::unique_ptr<llvm::raw_fd_ostream> out;
+
+  public:
+    explicit PerfMapPlugin(std::unique_ptr<llvm::raw_fd_ostream> out)
+        : out(std::move(out)) {}
+
+    void modifyPassConfig(llvm::orc::MaterializationResponsibility &,
+                          llvm::jitlink::LinkGraph &,
+                          llvm::jitlink::PassConfiguration &config) override {
+        // addresses are final once fixups have been applied
+        config.PostFixupPasses.push_back(
+            [this](llvm::jitlink::LinkGraph &g) -> llvm::Error {
+                writeSymbols(g);
+                return llvm::Error::success();
+            });
+    }
+
+    llvm::Error
+    notifyFailed(llvm::orc::MaterializationResponsibility &) override {
+        return llvm::Error::success();
+    }
+
+    llvm::Error notifyRemovingResources(llvm::orc::JITDylib &,
+                                        llvm::orc::ResourceKey) override {
+        return llvm::Error::success();
+    }
+
+    void notifyTransferringResources(llvm::orc::JITDylib &,
+                                     llvm::orc::ResourceKey,
+                                     llvm::orc::ResourceKey) override {}
+
+  private:
+    void writeSymbols(llvm::jitlink::LinkGraph &g) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (llvm::jitlink::Symbol *sym : g.defined_symbols()) {
+            if (!sym->hasName() || !sym->isCallable() || sym->getSize() == 0)
+                continue;
+            *out << llvm::format_hex_no_prefix(sym->getAddress().getValue(), 1)
+                 << ' ' << llvm::format_hex_no_prefix(sym->getSize(), 1) << ' '
+                 << sym->getName() << '\n';
+        }
+        out->flush();
+    }
+};
+
+} // namespace
+
+bool enablePerfMap(llvm::orc::LLJIT &jit) {
+    auto *linkingLayer = llvm::dyn_cast<llvm::orc::ObjectLinkingLayer>(
+        &jit.getObjLinkingLayer());
+    if (linkingLayer == nullptr) {
+        llvm::errs() << "warning: -perf-map is not supported by the JIT "
+                        "linker on this platform\n";
+        return false;
+    }
+
+    llvm::SmallString<64> path;
+    llvm::raw_svector_ostream(path)
+        << "/tmp/perf-" << llvm::sys::Process::getProcessId() << ".map";
+
+    std::error_code ec;
+    auto out = std::make_unique<llvm::raw_fd_ostream>(
+        path, ec, llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text);
+    if (ec) {
+        llvm::errs() << "warning: cannot open " << path << ": " << ec.message()
+                     << "\n";
+        return false;
+    }
+
+    linkingLayer->addPlugin(std::make_unique<PerfMapPlugin>(std::move(out)));
+    return true;
+}
+} // namespace ceramic
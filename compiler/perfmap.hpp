@@ -0,0 +1,11 @@
+#pragma once
+
+#include "ceramic.hpp"
+
+namespace ceramic {
+// Append a "<start> <size> <name>" line to /tmp/perf-<pid>.map for every
+// function linked by `jit`, so that `perf report` can attribute samples in
+// JIT code. Symbol names are the `getCodeName` names of the procedures.
+// Returns false if the JIT is not using a JITLink object linking layer.
+bool enablePerfMap(llvm::orc::LLJIT &jit);
+} // namespace ceramic
@@ -1073,7 +1073,7 @@ static void declareLLVMType(TypePtr t) {
     switch (t->typeKind) {
     case BOOL_TYPE: {
         t->llType = llvmIntType(1);
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createBasicType(
                 typeName(t), debugTypeSize(t->llType),
                 llvm::dwarf::DW_ATE_boolean));
@@ -1082,7 +1082,7 @@ static void declareLLVMType(TypePtr t) {
     case INTEGER_TYPE: {
         IntegerType *x = (IntegerType *)t.ptr();
         t->llType = llvmIntType(x->bits);
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createBasicType(
                 typeName(t), debugTypeSize(t->llType),
                 x->isSigned ? llvm::dwarf::DW_ATE_signed
@@ -1092,7 +1092,7 @@ static void declareLLVMType(TypePtr t) {
     case FLOAT_TYPE: {
         FloatType *x = (FloatType *)t.ptr();
         t->llType = llvmFloatType(x->bits);
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createBasicType(
                 typeName(t), debugTypeSize(t->llType),
                 x->isImaginary ? llvm::dwarf::DW_ATE_imaginary_float
@@ -1106,7 +1106,7 @@ static void declareLLVMType(TypePtr t) {
         llTypes.push_back(llvmType(realT));
         llTypes.push_back(llvmType(imagT));
         t->llType = llvm::StructType::create(llvmContext, llTypes, typeName(t));
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             t->debugInfo.reset(llvmDIBuilder->createBasicType(
                 typeName(t), debugTypeSize(t->llType),
                 llvm::dwarf::DW_ATE_complex_float));
@@ -1116,7 +1116,7 @@ static void declareLLVMType(TypePtr t) {
     case POINTER_TYPE: {
         PointerType *x = (PointerType *)t.ptr();
         t->llType = llvmPointerType(x->pointeeType);
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createPointerType(
                 llvmTypeDebugInfo(x->pointeeType), debugTypeSize(t->llType),
                 debugTypeAlignment(t->llType), std::nullopt, typeName(t)));
@@ -1137,7 +1137,7 @@ static void declareLLVMType(TypePtr t) {
         llvm::FunctionType *llFuncType =
             llvm::FunctionType::get(exceptionReturnType(), llArgTypes, false);
         t->llType = llvm::PointerType::getUnqual(llFuncType);
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             vector<llvm::Metadata *> debugParamTypes;
             debugParamTypes.push_back(llvmVoidTypeDebugInfo());
             for (size_t i = 0; i < x->argTypes.size(); ++i) {
@@ -1195,7 +1195,7 @@ static void declareLLVMType(TypePtr t) {
             t->llType = llvm::PointerType::getUnqual(llOpaqueFuncType);
         }
 
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::SmallVector<llvm::Metadata *, 16> debugParamTypes;
             debugParamTypes.push_back(x->returnType == nullptr
                                           ? llvmVoidTypeDebugInfo()
@@ -1221,7 +1221,7 @@ static void declareLLVMType(TypePtr t) {
     case ARRAY_TYPE: {
         ArrayType *x = (ArrayType *)t.ptr();
         t->llType = llvmArrayType(x->elementType, x->size);
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::Metadata *elementRange =
                 llvmDIBuilder->getOrCreateSubrange(0, x->size - 1);
             llvm::DINodeArray elementRangeArray =
@@ -1237,7 +1237,7 @@ static void declareLLVMType(TypePtr t) {
         VecType *x = (VecType *)t.ptr();
         t->llType =
             llvm::VectorType::get(llvmType(x->elementType), x->size, false);
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::Metadata *elementRange =
                 llvmDIBuilder->getOrCreateSubrange(0, x->size - 1);
             llvm::DINodeArray elementRangeArray =
@@ -1251,7 +1251,7 @@ static void declareLLVMType(TypePtr t) {
     }
     case TUPLE_TYPE: {
         t->llType = llvm::StructType::create(llvmContext, typeName(t));
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createReplaceableCompositeType(
                 llvm::dwarf::DW_TAG_structure_type, typeName(t),
                 /*Scope=*/nullptr, /*File=*/nullptr, /*Line=*/0));
@@ -1259,7 +1259,7 @@ static void declareLLVMType(TypePtr t) {
     }
     case UNION_TYPE: {
         t->llType = llvm::StructType::create(llvmContext, typeName(t));
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createReplaceableCompositeType(
                 llvm::dwarf::DW_TAG_union_type, typeName(t),
                 /*Scope=*/nullptr, /*File=*/nullptr, /*Line=*/0));
@@ -1267,7 +1267,7 @@ static void declareLLVMType(TypePtr t) {
     }
     case RECORD_TYPE: {
         t->llType = llvm::StructType::create(llvmContext, typeName(t));
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createReplaceableCompositeType(
                 llvm::dwarf::DW_TAG_structure_type, typeName(t),
                 /*Scope=*/nullptr, /*File=*/nullptr, /*Line=*/0));
@@ -1279,7 +1279,7 @@ static void declareLLVMType(TypePtr t) {
         if (!reprType->llType)
             declareLLVMType(reprType);
         t->llType = reprType->llType;
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createReplaceableCompositeType(
                 llvm::dwarf::DW_TAG_structure_type, typeName(t),
                 /*Scope=*/nullptr, /*File=*/nullptr, /*Line=*/0));
@@ -1287,7 +1287,7 @@ static void declareLLVMType(TypePtr t) {
     }
     case STATIC_TYPE: {
         t->llType = llvmStaticType();
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(llvmDIBuilder->createBasicType(
                 typeName(t), debugTypeSize(t->llType),
                 llvm::dwarf::DW_ATE_signed));
@@ -1295,7 +1295,7 @@ static void declareLLVMType(TypePtr t) {
     }
     case ENUM_TYPE: {
         t->llType = llvmType(cIntType);
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             EnumType *en = (EnumType *)t.ptr();
             llvm::SmallVector<llvm::Metadata *, 16> enumerators;
             for (vector<EnumMemberPtr>::const_iterator
@@ -1326,7 +1326,7 @@ static void declareLLVMType(TypePtr t) {
         if (!reprType->llType)
             declareLLVMType(reprType);
         t->llType = reprType->llType;
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(reprType->getDebugInfo());
         break;
     }
@@ -1367,7 +1367,7 @@ static void defineLLVMType(TypePtr t) {
 
         theType->setBody(llTypes);
 
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::MDNode *placeholderNode = x->getDebugInfo();
             llvm::DIScope *placeholder =
                 llvm::cast_or_null<llvm::DIScope>(placeholderNode);
@@ -1449,7 +1449,7 @@ static void defineLLVMType(TypePtr t) {
 
         theType->setBody(llTypes);
 
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::MDNode *placeholderNode = x->getDebugInfo();
             llvm::DIScope *placeholder =
                 llvm::cast_or_null<llvm::DIScope>(placeholderNode);
@@ -1508,7 +1508,7 @@ static void defineLLVMType(TypePtr t) {
 
         theType->setBody(llTypes);
 
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::MDNode *placeholderNode = x->getDebugInfo();
             llvm::DIScope *placeholder =
                 llvm::cast_or_null<llvm::DIScope>(placeholderNode);
@@ -1625,7 +1625,7 @@ static void defineLLVMType(TypePtr t) {
         if (!reprType->defined)
             defineLLVMType(reprType);
 
-        if (llvmDIBuilder != nullptr) {
+        if (fullDebugInfoEnabled()) {
             llvm::MDNode *placeholderNode = x->getDebugInfo();
             if (placeholderNode)
                 placeholderNode->replaceAllUsesWith(
@@ -1640,7 +1640,7 @@ static void defineLLVMType(TypePtr t) {
             declareLLVMType(reprType);
         if (!reprType->defined)
             defineLLVMType(reprType);
-        if (llvmDIBuilder != nullptr)
+        if (fullDebugInfoEnabled())
             t->debugInfo.reset(reprType->getDebugInfo());
         break;
     }
@@ -1681,7 +1681,7 @@ string typeName(const TypePtr &type) {
 }
 
 void materializeDebugInfoForTypes() {
-    if (llvmDIBuilder == nullptr)
+    if (!fullDebugInfoEnabled())
         return;
 
     bool changed = true;
@@ -0,0 +1,9 @@
+import sys
+
+sys.path.append("..")
+import ir_test
+
+# at -O0 only the front end inlines, so these scopes come from forceinline
+ir_test.checkInlined("scaled", "check")
+ir_test.checkInlined("spread", "check")
+ir_test.checkIR("emissionKind: FullDebug", "DILocalVariable")
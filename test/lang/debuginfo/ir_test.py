@@ -0,0 +1,60 @@
+import re
+from sys import argv
+
+# the test's output is LLVM IR text (-S -emit-llvm); these print what is
+# found in its metadata
+
+metadataLine = re.compile(r"^!(\d+) = (?:distinct )?!(\w+)\((.*)\)$", re.M)
+
+
+def readIR():
+    with open(argv[1], encoding="utf-8") as f:
+        return f.read()
+
+
+def checkIR(*patterns):
+    ir = readIR()
+    for pattern in patterns:
+        print(pattern, "found" if pattern in ir else "missing")
+
+
+def field(fields, name):
+    m = re.search(r"\b" + name + r": !(\d+)", fields)
+    return m.group(1) if m else None
+
+
+def subprogramName(nodes, scope):
+    # follow lexical blocks out to the procedure they are in
+    while scope is not None and scope in nodes:
+        kind, fields = nodes[scope]
+        if kind == "DISubprogram":
+            m = re.search(r'\bname: "([^"]*)"', fields)
+            return m.group(1) if m else None
+        scope = field(fields, "scope")
+    return None
+
+
+def namedAs(name, procedure):
+    # code names are qualified by module and may carry argument types
+    return name is not None and re.search(r"(^|\.)" + procedure + r"\b", name)
+
+
+# whether a location in callee's own scope is inlined, directly or through
+# other inlined procedures, at a location in caller
+def checkInlined(callee, caller):
+    nodes = {m.group(1): (m.group(2), m.group(3))
+             for m in metadataLine.finditer(readIR())}
+    inlined = False
+    for kind, fields in nodes.values():
+        if kind != "DILocation":
+            continue
+        if not namedAs(subprogramName(nodes, field(fields, "scope")), callee):
+            continue
+        at = field(fields, "inlinedAt")
+        while at is not None and at in nodes:
+            atFields = nodes[at][1]
+            if namedAs(subprogramName(nodes, field(atFields, "scope")), caller):
+                inlined = True
+                break
+            at = field(atFields, "inlinedAt")
+    print(callee, "inlined into", caller, "yes" if inlined else "no")
@@ -0,0 +1,9 @@
+import sys
+
+sys.path.append("..")
+import ir_test
+
+# line tables keep the inlined scopes but describe no variables
+ir_test.checkInlined("square", "distance2")
+ir_test.checkInlined("sumOfSquares", "distance2")
+ir_test.checkIR("emissionKind: LineTablesOnly", "DILocalVariable")
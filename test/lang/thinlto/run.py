@@ -0,0 +1,28 @@
+import os
+import shutil
+from subprocess import check_call, CalledProcessError
+from sys import argv, platform
+
+# link the -c -flto=thin object of main.crm with a second such unit, the way
+# a build of several units does, and run the program
+
+ceramicobj = argv[1]
+buildFlags = argv[2:]
+
+linkFlags = ["-flto=thin", "-O2"]
+if platform != "darwin" and shutil.which("ld.lld") is not None:
+    linkFlags += ["-fuse-ld=lld"]
+if platform == "linux" or platform == "linux2":
+    linkFlags += ["-lm", "-no-pie"]
+
+try:
+    os.rename(ceramicobj, "temp-main.o")
+    check_call(
+        [os.environ["CERAMIC"], "-c", "-flto=thin", "-O2", "-o", "temp-second.o"]
+        + buildFlags
+        + ["second.crm"]
+    )
+    check_call(["clang", "-o", "temp.exe", "temp-main.o", "temp-second.o"] + linkFlags)
+    check_call(["./temp.exe"])
+except CalledProcessError as ex:
+    print("!! error code", ex.returncode)
@@ -371,8 +371,14 @@ class TestCase(object):
                 outfilename,
             ] + self.opt.testBuildFlags
 
+        # run scripts that build more units find the compiler in $CERAMIC
+        env = dict(os.environ, CERAMIC=self.opt.ceramicCompiler)
         process = subprocess.Popen(
-            commandline, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
+            commandline,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            text=True,
+            env=env,
         )
         resultout, resulterr = process.communicate()
         self.removefile(outfilename)